@@ -5,9 +5,36 @@
 #include <fstream>
 #include <limits>
 #include <omp.h>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <cstring>
+#include <cmath>
+#include <queue>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <random>
+#include <map>
+#include <iomanip>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #define B 16
+#ifndef _OPENMP
+// Compilación secuencial (sin -fopenmp): las funciones de omp.h no se enlazan
+inline int omp_get_max_threads() { return 1; }
+inline void omp_set_num_threads(int) {}
+#endif
 using namespace std;
 const double INF = numeric_limits<double>::infinity();
+// Generadores en memoria (generarGrafoDirigidoAplanado / generarGrafoDirigidoCSR)
+#define GENERADOR_COMO_BIBLIOTECA
+#include "graphGeneratorV2.cpp"
 
 vector<vector<double>> leerGrafo(string nombreArchivo) {
     ifstream archivo(nombreArchivo);
@@ -106,15 +133,314 @@ vector<double> leerGrafoAplanado(string nombreArchivo) {
     
     return matriz;
 }
+
+// Grafo en formato CSR (lista de adyacencia compacta) leído directo de la
+// lista de aristas, sin formar la matriz de V x V.
+struct GrafoCSR {
+    int V = 0;
+    vector<long long> inicio;  // aristas de u: [inicio[u], inicio[u+1])
+    vector<int> destino;
+    vector<double> peso;
+};
+
+GrafoCSR construirCSR(int numVertices, const vector<int>& origenes, const vector<int>& destinos,
+                      const vector<double>& pesos) {
+    GrafoCSR g;
+    g.V = numVertices;
+    g.inicio.assign(numVertices + 1, 0);
+    for (int u : origenes) g.inicio[u + 1]++;
+    for (int u = 0; u < numVertices; ++u) g.inicio[u + 1] += g.inicio[u];
+    g.destino.resize(origenes.size());
+    g.peso.resize(origenes.size());
+    vector<long long> siguiente(g.inicio.begin(), g.inicio.end() - 1);
+    for (size_t e = 0; e < origenes.size(); ++e) {
+        long long pos = siguiente[origenes[e]]++;
+        g.destino[pos] = destinos[e];
+        g.peso[pos] = pesos[e];
+    }
+    return g;
+}
+
+GrafoCSR leerGrafoCSR(string nombreArchivo) {
+    ifstream archivo(nombreArchivo);
+
+    if (!archivo.is_open()) {
+        cerr << "Error: No se pudo abrir el archivo " << nombreArchivo << endl;
+        return {};
+    }
+
+    int numVertices;
+    long long numAristas;
+
+    archivo >> numVertices >> numAristas;
+
+    cout << "Leyendo grafo de " << numVertices << " vertices..." << endl;
+
+    vector<int> origenes, destinos;
+    vector<double> pesos;
+    origenes.reserve(numAristas);
+    destinos.reserve(numAristas);
+    pesos.reserve(numAristas);
+
+    int u, v;
+    double w;
+    while (archivo >> u >> v >> w) {
+        if (u >= 0 && u < numVertices && v >= 0 && v < numVertices && u != v) {
+            origenes.push_back(u);
+            destinos.push_back(v);
+            pesos.push_back(w);
+        }
+    }
+
+    archivo.close();
+    cout << "Lectura finalizada." << endl;
+
+    return construirCSR(numVertices, origenes, destinos, pesos);
+}
+
+// Igual que leerGrafoCSR pero generado en memoria (ver graphGeneratorV2.cpp)
+GrafoCSR generarGrafoCSR(int numVertices, int densidad, double pesoMin, double pesoMax,
+                         unsigned long long semilla) {
+    GrafoCSR g;
+    g.V = numVertices;
+    generarGrafoDirigidoCSR(numVertices, densidad, pesoMin, pesoMax, semilla, g.inicio, g.destino, g.peso);
+    return g;
+}
+
+// Checkpoints para corridas largas.
+// El archivo es una cabecera con la última k consistente seguida de la
+// matriz por filas. Cada K_CHECKPOINT iteraciones se copian al búfer solo
+// las filas modificadas desde el checkpoint anterior y un hilo las escribe
+// con pwrite; la cabecera se actualiza al final. Si el proceso muere a la
+// mitad quedan filas de una k posterior con la k anterior en la cabecera,
+// lo cual sigue siendo válido para reanudar: los valores solo bajan y
+// siempre son longitudes de caminos reales. La cabecera guarda además la
+// identidad de la entrada, y al terminar la corrida el archivo se borra.
+#define K_CHECKPOINT 64
+
+struct CabeceraCheckpoint {
+    char magia[4];
+    int32_t V;
+    int32_t k;      // -1 mientras no haya un checkpoint completo
+    int32_t reservado;
+    uint64_t identidad;
+};
+
+struct Checkpoint {
+    string ruta;
+    double maxSobrecarga = 2.0;  // % máximo del tiempo de cómputo
+    int kInicio = 0;             // k desde la que se reanuda
+    uint64_t identidad = 0;      // ver identidadArchivo
+
+    // Estado interno
+    int fd = -1;
+    int V = 0;
+    vector<char> filaModificada;
+    vector<pair<int, int>> tramos;  // filas [inicio, fin) copiadas al búfer
+    vector<double> bufer;
+    thread escritor;
+    atomic<bool> escribiendo{false};
+    bool falloEscritura = false;    // lo escribe el hilo antes de soltar escribiendo
+    chrono::high_resolution_clock::time_point inicio;
+    double segundosCheckpoint = 0;
+};
+
+bool escribirCompleto(int fd, const void* datos, size_t bytes, off_t desplazamiento) {
+    const char* p = (const char*)datos;
+    while (bytes > 0) {
+        ssize_t escritos = pwrite(fd, p, bytes, desplazamiento);
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += escritos;
+        bytes -= escritos;
+        desplazamiento += escritos;
+    }
+    return true;
+}
+
+// Identidad de un archivo de entrada: FNV-1a de la ruta, el tamaño y la
+// fecha de modificación. Un checkpoint solo se reanuda con la misma entrada.
+uint64_t identidadArchivo(const string& ruta) {
+    struct stat info;
+    if (stat(ruta.c_str(), &info) != 0) return 0;
+    uint64_t h = 1469598103934665603ULL;
+    auto mezclar = [&h](const void* datos, size_t bytes) {
+        const unsigned char* p = (const unsigned char*)datos;
+        for (size_t i = 0; i < bytes; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ULL;
+        }
+    };
+    mezclar(ruta.data(), ruta.size());
+    int64_t tamano = info.st_size, modificacion = info.st_mtime;
+    mezclar(&tamano, sizeof(tamano));
+    mezclar(&modificacion, sizeof(modificacion));
+    return h;
+}
+
+bool abrirCheckpoint(Checkpoint& c, int V) {
+    c.V = V;
+    if (c.kInicio == 0) {
+        // Corrida nueva: el primer checkpoint escribe la matriz completa
+        c.fd = open(c.ruta.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (c.fd < 0 || ftruncate(c.fd, sizeof(CabeceraCheckpoint) + (off_t)V * V * sizeof(double)) != 0) {
+            cerr << "Error: No se pudo crear el checkpoint " << c.ruta << endl;
+            return false;
+        }
+        CabeceraCheckpoint cabecera = {{'F', 'W', 'C', 'K'}, V, -1, 0, c.identidad};
+        escribirCompleto(c.fd, &cabecera, sizeof(cabecera), 0);
+        c.filaModificada.assign(V, 1);
+    } else {
+        c.fd = open(c.ruta.c_str(), O_RDWR);
+        if (c.fd < 0) {
+            cerr << "Error: No se pudo abrir el checkpoint " << c.ruta << endl;
+            return false;
+        }
+        c.filaModificada.assign(V, 0);
+    }
+    c.segundosCheckpoint = 0;
+    c.falloEscritura = false;
+    c.inicio = chrono::high_resolution_clock::now();
+    return true;
+}
+
+// Se llama con todos los hilos detenidos en la frontera de k.
+// Solo bloquea lo que tarda la copia de las filas modificadas.
+void tomarCheckpoint(Checkpoint& c, const vector<double>& dist, int k) {
+    if (c.fd < 0 || c.escribiendo) return;  // la escritura anterior sigue en curso
+
+    auto t0 = chrono::high_resolution_clock::now();
+    chrono::duration<double> transcurrido = t0 - c.inicio;
+    if (c.segundosCheckpoint > transcurrido.count() * c.maxSobrecarga / 100.0) return;
+
+    if (c.escritor.joinable()) c.escritor.join();
+    int V = c.V;
+    // Si la escritura anterior falló, sus filas siguen pendientes; de lo
+    // contrario la siguiente k se publicaría sobre filas viejas
+    if (c.falloEscritura) {
+        for (auto& tramo : c.tramos) {
+            for (int i = tramo.first; i < tramo.second; ++i) c.filaModificada[i] = 1;
+        }
+        c.falloEscritura = false;
+    }
+    c.tramos.clear();
+    size_t filas = 0;
+    for (int i = 0; i < V; ++i) {
+        if (!c.filaModificada[i]) continue;
+        if (!c.tramos.empty() && c.tramos.back().second == i) {
+            c.tramos.back().second = i + 1;
+        } else {
+            c.tramos.push_back({i, i + 1});
+        }
+        c.filaModificada[i] = 0;
+        filas++;
+    }
+    c.bufer.resize(filas * V);
+    double* destino = c.bufer.data();
+    for (auto& tramo : c.tramos) {
+        size_t n = (size_t)(tramo.second - tramo.first) * V;
+        memcpy(destino, &dist[(size_t)tramo.first * V], n * sizeof(double));
+        destino += n;
+    }
+
+    c.escribiendo = true;
+    c.escritor = thread([&c, k]() {
+        const double* origen = c.bufer.data();
+        bool ok = true;
+        for (auto& tramo : c.tramos) {
+            size_t n = (size_t)(tramo.second - tramo.first) * c.V;
+            off_t desplazamiento = sizeof(CabeceraCheckpoint) + (off_t)tramo.first * c.V * sizeof(double);
+            ok = ok && escribirCompleto(c.fd, origen, n * sizeof(double), desplazamiento);
+            origen += n;
+        }
+        // La k se publica solo cuando las filas ya están en disco
+        ok = ok && fdatasync(c.fd) == 0;
+        if (ok) {
+            int32_t k32 = k;
+            ok = escribirCompleto(c.fd, &k32, sizeof(k32), offsetof(CabeceraCheckpoint, k)) &&
+                 fdatasync(c.fd) == 0;
+        }
+        if (!ok) {
+            cerr << "Error: Fallo al escribir el checkpoint " << c.ruta << endl;
+            c.falloEscritura = true;
+        }
+        c.escribiendo = false;
+    });
+
+    chrono::duration<double> duracion = chrono::high_resolution_clock::now() - t0;
+    c.segundosCheckpoint += duracion.count();
+}
+
+// Los kernels la llaman al terminar: la corrida ya no necesita el archivo
+void cerrarCheckpoint(Checkpoint& c) {
+    if (c.escritor.joinable()) c.escritor.join();
+    if (c.fd >= 0) {
+        close(c.fd);
+        unlink(c.ruta.c_str());
+    }
+    c.fd = -1;
+}
+
+// Carga el último checkpoint consistente si pertenece a la entrada con esa
+// identidad. Después se asigna ckpt.kInicio = k y se vuelve a llamar al
+// mismo kernel.
+bool reanudarCheckpoint(const string& ruta, uint64_t identidad, vector<double>& dist, int& V, int& k) {
+    int fd = open(ruta.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    CabeceraCheckpoint cabecera;
+    bool ok = pread(fd, &cabecera, sizeof(cabecera), 0) == sizeof(cabecera) &&
+              memcmp(cabecera.magia, "FWCK", 4) == 0 && cabecera.k >= 0;
+    if (ok && cabecera.identidad != identidad) {
+        cerr << "Error: El checkpoint " << ruta << " es de otra entrada" << endl;
+        close(fd);
+        return false;
+    }
+    if (ok) {
+        V = cabecera.V;
+        k = cabecera.k;
+        dist.resize((size_t)V * V);
+        size_t bytes = dist.size() * sizeof(double);
+        char* p = (char*)dist.data();
+        off_t desplazamiento = sizeof(cabecera);
+        while (ok && bytes > 0) {
+            ssize_t leidos = pread(fd, p, bytes, desplazamiento);
+            ok = leidos > 0;
+            if (ok) {
+                p += leidos;
+                bytes -= leidos;
+                desplazamiento += leidos;
+            }
+        }
+    }
+    close(fd);
+    if (!ok) cerr << "Error: Checkpoint no valido " << ruta << endl;
+    return ok;
+}
+
+// Ciclos negativos: si dist[i][i] < 0 en cualquier momento del bucle k,
+// existe un ciclo negativo que pasa por i. Los kernels revisan la diagonal
+// de cada fila justo después de actualizarla, abortan y devuelven true;
+// si se pasa cicloNegativo, se llena con los vértices de diagonal negativa.
+void reportarCicloNegativo(const vector<double>& dist, int V, vector<int>* cicloNegativo) {
+    if (cicloNegativo == nullptr) return;
+    cicloNegativo->clear();
+    for (int i = 0; i < V; i++) {
+        if (dist[(size_t)i * V + i] < 0) cicloNegativo->push_back(i);
+    }
+}
+
 // Solves the all-pairs shortest path
 // problem using Floyd Warshall algorithm
 // obtenido de Geeks for geeks
-void floydWarshall(vector<vector<double>> &dist) {
+bool floydWarshall(vector<vector<double>> &dist, vector<int>* cicloNegativo = nullptr) {
     int V = dist.size();
+    bool negativo = false;
 
     // Add all vertices one by one to
     // the set of intermediate vertices.
-    for (int k = 0; k < V; k++) {
+    for (int k = 0; k < V && !negativo; k++) {
 
         // Pick all vertices as source one by one
         for (int i = 0; i < V; i++) {
@@ -128,14 +454,27 @@ void floydWarshall(vector<vector<double>> &dist) {
                 if(dist[i][k] != INF && dist[k][j]!= INF)
                 dist[i][j] = min(dist[i][j],dist[i][k] + dist[k][j]);
             }
+            if (dist[i][i] < 0) negativo = true;
         }
         
     }
+    if (negativo && cicloNegativo != nullptr) {
+        cicloNegativo->clear();
+        for (int i = 0; i < V; i++) {
+            if (dist[i][i] < 0) cicloNegativo->push_back(i);
+        }
+    }
+    return negativo;
 }
 
-void floydWarshallSecuencialOptimizado(vector<double>& dist, int V) {
+bool floydWarshallSecuencialOptimizado(vector<double>& dist, int V, vector<int>* cicloNegativo = nullptr,
+                                       Checkpoint* ckpt = nullptr) {
+    bool negativo = false;
+    if (ckpt != nullptr && !abrirCheckpoint(*ckpt, V)) ckpt = nullptr;
+    char* modificadas = ckpt != nullptr ? ckpt->filaModificada.data() : nullptr;
+    int kInicio = ckpt != nullptr ? ckpt->kInicio : 0;
 
-    for (int k = 0; k < V; k++) {
+    for (int k = kInicio; k < V && !negativo; k++) {
         // Optimización de acceso a la fila K:
         double* rowK = &dist[k * V];
         for (int i = 0; i < V; i++) {
@@ -146,22 +485,33 @@ void floydWarshallSecuencialOptimizado(vector<double>& dist, int V) {
             // Guardamos el valor para acceso rapido
             double dist_ik = rowI[k];
             //instrucciones SIMD
+            bool cambio = false;
             for (int j = 0; j < V; j++) {
                 double new_dist = dist_ik + rowK[j];
                 if (new_dist < rowI[j]) {
                     rowI[j] = new_dist;
+                    cambio = true;
                 }
             }
+            if (cambio && modificadas != nullptr) modificadas[i] = 1;
+            if (rowI[i] < 0) negativo = true;
+        }
+        if (ckpt != nullptr && !negativo && (k + 1) % K_CHECKPOINT == 0) {
+            tomarCheckpoint(*ckpt, dist, k + 1);
         }
     }
+    if (ckpt != nullptr) cerrarCheckpoint(*ckpt);
+    if (negativo) reportarCicloNegativo(dist, V, cicloNegativo);
+    return negativo;
 }
 
-void floydWarshallOMP(vector<vector<double>> &dist) {
+bool floydWarshallOMP(vector<vector<double>> &dist, vector<int>* cicloNegativo = nullptr) {
     int V = dist.size();
+    bool negativo = false;
 
     // Add all vertices one by one to
     // the set of intermediate vertices.
-    for (int k = 0; k < V; k++) {
+    for (int k = 0; k < V && !negativo; k++) {
 
         // Pick all vertices as source one by one
         #pragma omp parallel for schedule(static)
@@ -176,34 +526,81 @@ void floydWarshallOMP(vector<vector<double>> &dist) {
                 if(dist[i][k] != 1e8 && dist[k][j]!= 1e8)
                 dist[i][j] = min(dist[i][j],dist[i][k] + dist[k][j]);
             }
+            if (dist[i][i] < 0) {
+                #pragma omp atomic write
+                negativo = true;
+            }
         }
         
     }
+    if (negativo && cicloNegativo != nullptr) {
+        cicloNegativo->clear();
+        for (int i = 0; i < V; i++) {
+            if (dist[i][i] < 0) cicloNegativo->push_back(i);
+        }
+    }
+    return negativo;
 }
 
-void floydWarshallOMPOptimized(vector<double> &dist, int V) {
+// Bucle interno de floydWarshallOMPOptimized: relaja la fila i con la fila k.
+// Devuelve true si cambió algún valor.
+inline bool relajarFila(double* filaI, const double* filaK, double dist_ik, int V) {
+    // Bucle vectorizable
+    bool cambio = false;
+    #pragma omp simd reduction(||:cambio)
+    for (int j = 0; j < V; j++) {
+        double sum = dist_ik + filaK[j];
+        
+        if (sum < filaI[j]) {
+            filaI[j] = sum;
+            cambio = true;
+        }
+    }
+    return cambio;
+}
+
+bool floydWarshallOMPOptimized(vector<double> &dist, int V, vector<int>* cicloNegativo = nullptr,
+                               Checkpoint* ckpt = nullptr) {
+    // Una bandera por paridad de k: lo escrito en la iteración k se lee
+    // después de la barrera implícita del for, mientras los hilos que ya
+    // avanzaron a k+1 escriben en la otra. Así todos salen en la misma k
+    // sin agregar otra barrera.
+    bool negativo[2] = {false, false};
+    if (ckpt != nullptr && !abrirCheckpoint(*ckpt, V)) ckpt = nullptr;
+    char* modificadas = ckpt != nullptr ? ckpt->filaModificada.data() : nullptr;
+    int kInicio = ckpt != nullptr ? ckpt->kInicio : 0;
     // Los hilos se crean una sola vez.
     #pragma omp parallel
     {
-        for (int k = 0; k < V; k++) {
+        for (int k = kInicio; k < V; k++) {
             #pragma omp for schedule(static)
             for (int i = 0; i < V; i++) {
                 
                 double dist_ik = dist[i * V + k];
                 if (dist_ik == INF) continue;
-                // Bucle vectorizable
-                #pragma omp simd
-                for (int j = 0; j < V; j++) {
-                    double &res = dist[i * V + j];
-                    double sum = dist_ik + dist[k * V + j];
-                    
-                    if (sum < res) {
-                        res = sum;
-                    }
+                bool cambio = relajarFila(&dist[i * V], &dist[k * V], dist_ik, V);
+                if (cambio && modificadas != nullptr) modificadas[i] = 1;
+                if (dist[i * V + i] < 0) {
+                    #pragma omp atomic write
+                    negativo[k & 1] = true;
                 }
             }
+            bool abortar;
+            #pragma omp atomic read
+            abortar = negativo[k & 1];
+            if (abortar) break;
+            // Todos los hilos llegan aquí con la misma k; single los detiene
+            // mientras se copian las filas modificadas
+            if (ckpt != nullptr && (k + 1) % K_CHECKPOINT == 0) {
+                #pragma omp single
+                tomarCheckpoint(*ckpt, dist, k + 1);
+            }
         }
     }
+    if (ckpt != nullptr) cerrarCheckpoint(*ckpt);
+    bool hayCiclo = negativo[0] || negativo[1];
+    if (hayCiclo) reportarCicloNegativo(dist, V, cicloNegativo);
+    return hayCiclo;
 }
 
 
@@ -215,13 +612,57 @@ void floydWarshallOMPOptimized(vector<double> &dist, int V) {
 
 
 
+// Resumen de un bloque BxB para el solver por bloques.
+// numINF: celdas del bloque que siguen en INF (todo INF si numINF == celdas)
+// minimo: menor valor finito del bloque
+// maximo: cota superior del mayor valor finito (los valores solo bajan)
+// modificado: hubo escrituras desde el último checkpoint
+struct ResumenBloque {
+    int numINF;
+    int celdas;
+    double minimo;
+    double maximo;
+    bool modificado;
+};
+
+ResumenBloque resumirBloque(const vector<double>& dist, int N, int r_i, int r_j) {
+    int i_end = std::min(r_i + B, N);
+    int j_end = std::min(r_j + B, N);
+    ResumenBloque res = {0, (i_end - r_i) * (j_end - r_j), INF, -INF, false};
+    for (int i = r_i; i < i_end; ++i) {
+        for (int j = r_j; j < j_end; ++j) {
+            double d = dist[i * N + j];
+            if (d == INF) {
+                res.numINF++;
+            } else {
+                res.minimo = std::min(res.minimo, d);
+                res.maximo = std::max(res.maximo, d);
+            }
+        }
+    }
+    return res;
+}
+
+bool bloqueTodoINF(const ResumenBloque& res) {
+    return res.numINF == res.celdas;
+}
+
 // Versión corregida de update_block
-void update_block(vector<double>&dist, int N, int r_i, int r_j, int r_k, int block_k) {
+// Actualiza el bloque (r_i, r_j) y su resumen con los valores escritos.
+// Devuelve true si el bloque es diagonal y quedó un dist[i][i] < 0.
+bool update_block(vector<double>&dist, int N, int r_i, int r_j, int r_k, int block_k,
+                  ResumenBloque& res) {
     int i_end = std::min(r_i + B, N);
     int j_end = std::min(r_j + B, N);
     int k_end = std::min(r_k + B, N);
     
+    bool diagonal = (r_i == r_j);
+    bool negativo = false;
+    int nuevosFinitos = 0;
+    double nuevoMin = INF;
+    double nuevoMax = -INF;
     for (int k = block_k; k < block_k + B && k < N; ++k) {
+        const double* dist_k = &dist[k * N];
         for (int i = r_i; i < i_end; ++i) {
             double dik = dist[i * N + k];
             if (dik == INF) continue;
@@ -229,53 +670,1141 @@ void update_block(vector<double>&dist, int N, int r_i, int r_j, int r_k, int blo
             // Optimización: precargar fila i en localidad temporal
             double* dist_i = &dist[i * N];
             
-            #pragma omp simd aligned(dist:64)
+            #pragma omp simd reduction(+:nuevosFinitos) reduction(min:nuevoMin) reduction(max:nuevoMax)
             for (int j = r_j; j < j_end; ++j) {
-                double new_dist = dik + dist[k * N + j];
+                double new_dist = dik + dist_k[j];
                 if (new_dist < dist_i[j]) {
+                    if (dist_i[j] == INF) nuevosFinitos++;
                     dist_i[j] = new_dist;
+                    nuevoMin = std::min(nuevoMin, new_dist);
+                    nuevoMax = std::max(nuevoMax, new_dist);
                 }
             }
+            if (diagonal && dist_i[i] < 0) negativo = true;
         }
     }
+    res.numINF -= nuevosFinitos;
+    res.minimo = std::min(res.minimo, nuevoMin);
+    res.maximo = std::max(res.maximo, nuevoMax);
+    if (nuevoMin != INF) res.modificado = true;
+    return negativo;
 }
 
-void blocked_floyd_warshall(vector<double>& dist, int N) {
+bool blocked_floyd_warshall(vector<double>& dist, int N, vector<int>* cicloNegativo = nullptr,
+                            Checkpoint* ckpt = nullptr) {
     // Asegurar que los bloques no excedan N
     int blocks = (N + B - 1) / B;
+
+    // Resumen de cada bloque (ib, jb) en resumen[ib * blocks + jb]
+    vector<ResumenBloque> resumen(blocks * blocks);
+    for (int ib = 0; ib < blocks; ++ib) {
+        for (int jb = 0; jb < blocks; ++jb) {
+            resumen[ib * blocks + jb] = resumirBloque(dist, N, ib * B, jb * B);
+        }
+    }
+    
+    if (ckpt != nullptr && !abrirCheckpoint(*ckpt, N)) ckpt = nullptr;
+    // Los checkpoints se toman en fronteras de bloque; si se reanuda a
+    // mitad de un bloque se repite desde su inicio, lo cual es seguro.
+    int kbInicio = ckpt != nullptr ? ckpt->kInicio / B : 0;
     
-    for (int kb = 0; kb < blocks; ++kb) {
+    for (int kb = kbInicio; kb < blocks; ++kb) {
         int k_start = kb * B;
         int k_end = std::min(k_start + B, N);
         
         // Fase 1: Bloque diagonal (actualización dentro del bloque k)
-        update_block(dist, N, k_start, k_start, k_start, k_start);
+        bool negativo = update_block(dist, N, k_start, k_start, k_start, k_start, resumen[kb * blocks + kb]);
         
         // Fase 2: Bloques en la misma fila y columna
+        // Un bloque del panel todo INF no puede mejorar: sus dik (o dkj) son INF.
         for (int ib = 0; ib < blocks; ++ib) {
             if (ib == kb) continue;
             int i_start = ib * B;
             
             // Columnas del bloque k para filas i
-            update_block(dist, N, i_start, k_start, k_start, k_start);
+            ResumenBloque& col = resumen[ib * blocks + kb];
+            if (!bloqueTodoINF(col))
+                update_block(dist, N, i_start, k_start, k_start, k_start, col);
             
             // Filas del bloque k para columnas j
-            update_block(dist, N, k_start, i_start, k_start, k_start);
+            ResumenBloque& fila = resumen[kb * blocks + ib];
+            if (!bloqueTodoINF(fila))
+                update_block(dist, N, k_start, i_start, k_start, k_start, fila);
         }
         
         // Fase 3: Resto de la matriz
         for (int ib = 0; ib < blocks; ++ib) {
             if (ib == kb) continue;
+            const ResumenBloque& col = resumen[ib * blocks + kb];
+            // Toda la fila de bloques ib se salta si su pivote de columna es INF
+            if (bloqueTodoINF(col)) continue;
             for (int jb = 0; jb < blocks; ++jb) {
                 if (jb == kb) continue;
+                const ResumenBloque& fila = resumen[kb * blocks + jb];
+                if (bloqueTodoINF(fila)) continue;
+
+                // Si el bloque no tiene INF y ni la menor suma posible
+                // baja de su máximo, no hay nada que mejorar
+                ResumenBloque& actual = resumen[ib * blocks + jb];
+                if (actual.numINF == 0 && col.minimo + fila.minimo >= actual.maximo) continue;
                 
                 int i_start = ib * B;
                 int j_start = jb * B;
                 
-                update_block(dist, N, i_start, j_start, k_start, k_start);
+                if (update_block(dist, N, i_start, j_start, k_start, k_start, actual))
+                    negativo = true;
+            }
+        }
+        // Los bloques diagonales ya se revisaron en las fases 1 y 3
+        if (negativo) {
+            if (ckpt != nullptr) cerrarCheckpoint(*ckpt);
+            reportarCicloNegativo(dist, N, cicloNegativo);
+            return true;
+        }
+
+        if (ckpt != nullptr && k_end % K_CHECKPOINT == 0) {
+            // Pasar las marcas de los bloques a filas
+            for (int ib = 0; ib < blocks; ++ib) {
+                for (int jb = 0; jb < blocks; ++jb) {
+                    ResumenBloque& r = resumen[ib * blocks + jb];
+                    if (!r.modificado) continue;
+                    r.modificado = false;
+                    for (int i = ib * B; i < std::min(ib * B + B, N); ++i) ckpt->filaModificada[i] = 1;
+                }
+            }
+            tomarCheckpoint(*ckpt, dist, k_end);
+        }
+    }
+    if (ckpt != nullptr) cerrarCheckpoint(*ckpt);
+    return false;
+}
+
+// Reordenamiento de vértices antes de resolver.
+// orden[p] es el vértice original que queda en la posición p.
+enum OrdenVertices { ORDEN_ORIGINAL, ORDEN_COMPONENTES, ORDEN_GRADO, ORDEN_RCM };
+
+// Componentes fuertemente conexas (Tarjan iterativo) en orden topológico.
+// En grafos tipo DAG deja casi todo bajo la diagonal en INF, así las filas
+// i > k se saltan en los kernels planos y los bloques inferiores en el de bloques.
+vector<int> ordenPorComponentes(const vector<double>& dist, int V) {
+    vector<int> indice(V, -1), bajo(V, 0), siguiente(V, 0);
+    vector<char> enPila(V, 0);
+    vector<int> pila, llamadas, orden;
+    orden.reserve(V);
+    int contador = 0;
+
+    for (int s = 0; s < V; ++s) {
+        if (indice[s] != -1) continue;
+        llamadas.push_back(s);
+        indice[s] = bajo[s] = contador++;
+        pila.push_back(s);
+        enPila[s] = 1;
+
+        while (!llamadas.empty()) {
+            int u = llamadas.back();
+            const double* filaU = &dist[(size_t)u * V];
+            int &j = siguiente[u];
+            // Buscar el siguiente vecino sin visitar
+            while (j < V && (j == u || filaU[j] == INF || (indice[j] != -1 && !enPila[j]))) {
+                j++;
+            }
+            if (j < V) {
+                int v = j++;
+                if (indice[v] == -1) {
+                    indice[v] = bajo[v] = contador++;
+                    pila.push_back(v);
+                    enPila[v] = 1;
+                    llamadas.push_back(v);
+                } else {
+                    bajo[u] = min(bajo[u], indice[v]);
+                }
+                continue;
+            }
+            // u terminado: cerrar componente si es raíz
+            llamadas.pop_back();
+            if (!llamadas.empty()) {
+                int padre = llamadas.back();
+                bajo[padre] = min(bajo[padre], bajo[u]);
+            }
+            if (bajo[u] == indice[u]) {
+                int v;
+                do {
+                    v = pila.back();
+                    pila.pop_back();
+                    enPila[v] = 0;
+                    orden.push_back(v);
+                } while (v != u);
+            }
+        }
+    }
+    // Tarjan entrega las componentes en orden topológico inverso
+    reverse(orden.begin(), orden.end());
+    return orden;
+}
+
+// Vértices con más aristas (entrada + salida) primero
+vector<int> ordenPorGrado(const vector<double>& dist, int V) {
+    vector<int> grado(V, 0);
+    for (int i = 0; i < V; ++i) {
+        for (int j = 0; j < V; ++j) {
+            if (i != j && dist[(size_t)i * V + j] != INF) {
+                grado[i]++;
+                grado[j]++;
+            }
+        }
+    }
+    vector<int> orden(V);
+    for (int i = 0; i < V; ++i) orden[i] = i;
+    stable_sort(orden.begin(), orden.end(), [&](int a, int b) { return grado[a] > grado[b]; });
+    return orden;
+}
+
+// Reverse Cuthill-McKee sobre el grafo simetrizado: agrupa los valores
+// finitos cerca de la diagonal (banda estrecha).
+vector<int> ordenCuthillMcKee(const vector<double>& dist, int V) {
+    vector<vector<int>> vecinos(V);
+    for (int i = 0; i < V; ++i) {
+        for (int j = i + 1; j < V; ++j) {
+            if (dist[(size_t)i * V + j] != INF || dist[(size_t)j * V + i] != INF) {
+                vecinos[i].push_back(j);
+                vecinos[j].push_back(i);
+            }
+        }
+    }
+    for (int i = 0; i < V; ++i) {
+        sort(vecinos[i].begin(), vecinos[i].end(),
+             [&](int a, int b) { return vecinos[a].size() < vecinos[b].size(); });
+    }
+
+    vector<int> orden;
+    orden.reserve(V);
+    vector<char> visitado(V, 0);
+    while ((int)orden.size() < V) {
+        // Cada componente empieza en su vértice de menor grado
+        int inicio = -1;
+        for (int i = 0; i < V; ++i) {
+            if (!visitado[i] && (inicio == -1 || vecinos[i].size() < vecinos[inicio].size())) {
+                inicio = i;
+            }
+        }
+        size_t cabeza = orden.size();
+        orden.push_back(inicio);
+        visitado[inicio] = 1;
+        while (cabeza < orden.size()) {
+            int u = orden[cabeza++];
+            for (int v : vecinos[u]) {
+                if (!visitado[v]) {
+                    visitado[v] = 1;
+                    orden.push_back(v);
+                }
+            }
+        }
+    }
+    reverse(orden.begin(), orden.end());
+    return orden;
+}
+
+vector<int> calcularOrden(const vector<double>& dist, int V, OrdenVertices tipo) {
+    switch (tipo) {
+        case ORDEN_COMPONENTES: return ordenPorComponentes(dist, V);
+        case ORDEN_GRADO:       return ordenPorGrado(dist, V);
+        case ORDEN_RCM:         return ordenCuthillMcKee(dist, V);
+        default: {
+            vector<int> orden(V);
+            for (int i = 0; i < V; ++i) orden[i] = i;
+            return orden;
+        }
+    }
+}
+
+// permutada[p][q] = dist[orden[p]][orden[q]]
+vector<double> permutarMatriz(const vector<double>& dist, int V, const vector<int>& orden) {
+    vector<double> permutada((size_t)V * V);
+    #pragma omp parallel for schedule(static)
+    for (int p = 0; p < V; ++p) {
+        const double* origen = &dist[(size_t)orden[p] * V];
+        double* destino = &permutada[(size_t)p * V];
+        for (int q = 0; q < V; ++q) {
+            destino[q] = origen[orden[q]];
+        }
+    }
+    return permutada;
+}
+
+// Operación inversa: regresa los resultados a los ids originales
+void restaurarMatriz(const vector<double>& permutada, vector<double>& dist, int V, const vector<int>& orden) {
+    #pragma omp parallel for schedule(static)
+    for (int p = 0; p < V; ++p) {
+        const double* origen = &permutada[(size_t)p * V];
+        double* destino = &dist[(size_t)orden[p] * V];
+        for (int q = 0; q < V; ++q) {
+            destino[orden[q]] = origen[q];
+        }
+    }
+}
+
+// Reordena, resuelve con el kernel indicado y devuelve el resultado
+// en la numeración original de los vértices.
+bool floydWarshallReordenado(vector<double>& dist, int V, OrdenVertices tipo,
+                             bool (*solver)(vector<double>&, int, vector<int>*, Checkpoint*),
+                             vector<int>* cicloNegativo = nullptr) {
+    if (tipo == ORDEN_ORIGINAL) {
+        return solver(dist, V, cicloNegativo, nullptr);
+    }
+    vector<int> orden = calcularOrden(dist, V, tipo);
+    vector<double> permutada = permutarMatriz(dist, V, orden);
+    bool negativo = solver(permutada, V, cicloNegativo, nullptr);
+    restaurarMatriz(permutada, dist, V, orden);
+    if (negativo && cicloNegativo != nullptr) {
+        for (int& v : *cicloNegativo) v = orden[v];
+        sort(cicloNegativo->begin(), cicloNegativo->end());
+    }
+    return negativo;
+}
+
+// Floyd-Warshall por particiones (descomposición con vértices frontera).
+// 1. Se parte el grafo: componentes débilmente conexas, y las que pasan de
+//    TAM_PARTE vértices se cortan en trozos siguiendo el orden RCM.
+// 2. Se resuelve cada parte por separado con los kernels existentes.
+// 3. Se resuelve el grafo de fronteras (vértices con aristas entre partes).
+// 4. dist[u][v] = min(D_P[u][v], min_{a,b} D_P[u][a] + D_S[a][b] + D_Q[b][v])
+//    con a frontera de la parte P de u y b frontera de la parte Q de v.
+// El trabajo cúbico depende del tamaño de las partes y de la frontera, no de V.
+#define TAM_PARTE 1024
+
+int raizConjunto(vector<int>& padre, int x) {
+    while (padre[x] != x) {
+        padre[x] = padre[padre[x]];
+        x = padre[x];
+    }
+    return x;
+}
+
+vector<vector<int>> particionarVertices(const vector<double>& dist, int V) {
+    vector<int> padre(V);
+    for (int i = 0; i < V; ++i) padre[i] = i;
+    for (int i = 0; i < V; ++i) {
+        for (int j = 0; j < V; ++j) {
+            if (i != j && dist[(size_t)i * V + j] != INF) {
+                padre[raizConjunto(padre, i)] = raizConjunto(padre, j);
             }
         }
     }
+    // RCM deja cada componente contigua y con banda estrecha, así que
+    // cortar en trozos consecutivos corta pocas aristas
+    vector<int> orden = ordenCuthillMcKee(dist, V);
+    vector<vector<int>> partes;
+    int componenteActual = -1;
+    for (int v : orden) {
+        int componente = raizConjunto(padre, v);
+        if (componente != componenteActual || (int)partes.back().size() == TAM_PARTE) {
+            partes.push_back({});
+            componenteActual = componente;
+        }
+        partes.back().push_back(v);
+    }
+    return partes;
+}
+
+bool floydWarshallParticionado(vector<double>& dist, int V, vector<int>* cicloNegativo = nullptr) {
+    vector<vector<int>> partes = particionarVertices(dist, V);
+    int numPartes = partes.size();
+    if (numPartes <= 1) {
+        return floydWarshallOMPOptimized(dist, V, cicloNegativo);
+    }
+
+    vector<int> parte(V), local(V);
+    for (int p = 0; p < numPartes; ++p) {
+        for (int l = 0; l < (int)partes[p].size(); ++l) {
+            parte[partes[p][l]] = p;
+            local[partes[p][l]] = l;
+        }
+    }
+
+    // Vértices frontera: tienen alguna arista (de entrada o salida) a otra parte
+    vector<char> esFrontera(V, 0);
+    for (int u = 0; u < V; ++u) {
+        for (int v = 0; v < V; ++v) {
+            if (parte[u] != parte[v] && dist[(size_t)u * V + v] != INF) {
+                esFrontera[u] = esFrontera[v] = 1;
+            }
+        }
+    }
+    vector<int> frontera, indiceFrontera(V, -1);
+    // fronteraLocal[p]: índices locales dentro de p de sus vértices frontera
+    vector<vector<int>> fronteraLocal(numPartes);
+    for (int p = 0; p < numPartes; ++p) {
+        for (int v : partes[p]) {
+            if (!esFrontera[v]) continue;
+            indiceFrontera[v] = frontera.size();
+            frontera.push_back(v);
+            fronteraLocal[p].push_back(local[v]);
+        }
+    }
+    int S = frontera.size();
+
+    // Costo estimado: soluciones locales + grafo de fronteras + combinación.
+    // En componentes densas casi todo vértice es frontera y partir sale más
+    // caro que el kernel completo; en ese caso se usa floydWarshallOMPOptimized.
+    double costeLocal = 0, fronteraPorParte = 0, costeSalida = 0;
+    for (int p = 0; p < numPartes; ++p) {
+        double n = partes[p].size();
+        costeLocal += n * n * n;
+        fronteraPorParte += fronteraLocal[p].size() * n;
+    }
+    for (int p = 0; p < numPartes; ++p) {
+        costeSalida += (double)partes[p].size() * fronteraLocal[p].size() * S;
+    }
+    double costeParticion = costeLocal + (double)S * S * S + costeSalida + (double)V * fronteraPorParte;
+    if (4 * S > V || costeParticion > 0.5 * (double)V * V * V) {
+        return floydWarshallOMPOptimized(dist, V, cicloNegativo);
+    }
+
+    // Matrices locales de cada parte
+    vector<vector<double>> locales(numPartes);
+    for (int p = 0; p < numPartes; ++p) {
+        int n = partes[p].size();
+        locales[p].resize((size_t)n * n);
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < n; ++b) {
+                locales[p][(size_t)a * n + b] = dist[(size_t)partes[p][a] * V + partes[p][b]];
+            }
+        }
+    }
+
+    // Con muchas partes se reparten entre hilos con el kernel secuencial;
+    // con pocas, cada una usa todos los hilos.
+    vector<char> negativoParte(numPartes, 0);
+    if (numPartes >= omp_get_max_threads()) {
+        #pragma omp parallel for schedule(dynamic)
+        for (int p = 0; p < numPartes; ++p) {
+            negativoParte[p] = floydWarshallSecuencialOptimizado(locales[p], partes[p].size());
+        }
+    } else {
+        for (int p = 0; p < numPartes; ++p) {
+            negativoParte[p] = floydWarshallOMPOptimized(locales[p], partes[p].size());
+        }
+    }
+
+    bool negativo = false;
+    vector<int> ciclo;
+    for (int p = 0; p < numPartes; ++p) {
+        if (!negativoParte[p]) continue;
+        negativo = true;
+        int n = partes[p].size();
+        for (int l = 0; l < n; ++l) {
+            if (locales[p][(size_t)l * n + l] < 0) ciclo.push_back(partes[p][l]);
+        }
+    }
+
+    // Grafo de fronteras: caminos internos de cada parte + aristas entre partes
+    vector<double> fronteras((size_t)S * S, INF);
+    if (!negativo) {
+        for (int p = 0; p < numPartes; ++p) {
+            int n = partes[p].size();
+            for (int a : fronteraLocal[p]) {
+                for (int b : fronteraLocal[p]) {
+                    fronteras[(size_t)indiceFrontera[partes[p][a]] * S + indiceFrontera[partes[p][b]]] =
+                        locales[p][(size_t)a * n + b];
+                }
+            }
+        }
+        for (int s = 0; s < S; ++s) {
+            int u = frontera[s];
+            for (int t = 0; t < S; ++t) {
+                int v = frontera[t];
+                double w = dist[(size_t)u * V + v];
+                if (parte[u] != parte[v] && w < fronteras[(size_t)s * S + t]) {
+                    fronteras[(size_t)s * S + t] = w;
+                }
+            }
+        }
+        vector<int> cicloFrontera;
+        if (floydWarshallOMPOptimized(fronteras, S, &cicloFrontera)) {
+            negativo = true;
+            for (int s : cicloFrontera) ciclo.push_back(frontera[s]);
+        }
+    }
+
+    if (negativo) {
+        if (cicloNegativo != nullptr) {
+            sort(ciclo.begin(), ciclo.end());
+            *cicloNegativo = ciclo;
+        }
+        return true;
+    }
+
+    // Combinación con productos min-plus
+    #pragma omp parallel
+    {
+        vector<double> salida(S);
+        #pragma omp for schedule(dynamic, 16)
+        for (int u = 0; u < V; ++u) {
+            int p = parte[u];
+            int nP = partes[p].size();
+            const double* filaLocal = &locales[p][(size_t)local[u] * nP];
+            double* filaU = &dist[(size_t)u * V];
+
+            // salida[t] = min_a D_P[u][a] + D_S[a][t]: mejor camino de u a la frontera t
+            fill(salida.begin(), salida.end(), INF);
+            for (int a : fronteraLocal[p]) {
+                double dua = filaLocal[a];
+                if (dua == INF) continue;
+                const double* filaS = &fronteras[(size_t)indiceFrontera[partes[p][a]] * S];
+                #pragma omp simd
+                for (int t = 0; t < S; ++t) {
+                    double sum = dua + filaS[t];
+                    if (sum < salida[t]) salida[t] = sum;
+                }
+            }
+
+            for (int q = 0; q < numPartes; ++q) {
+                int nQ = partes[q].size();
+                const vector<int>& verticesQ = partes[q];
+                for (int l = 0; l < nQ; ++l) {
+                    filaU[verticesQ[l]] = (q == p) ? filaLocal[l] : INF;
+                }
+                for (int b : fronteraLocal[q]) {
+                    double dub = salida[indiceFrontera[verticesQ[b]]];
+                    if (dub == INF) continue;
+                    const double* filaQ = &locales[q][(size_t)b * nQ];
+                    for (int l = 0; l < nQ; ++l) {
+                        double sum = dub + filaQ[l];
+                        if (sum < filaU[verticesQ[l]]) filaU[verticesQ[l]] = sum;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Distancias desde una sola fuente (Dijkstra con heap binario).
+// Con potencial (Johnson) se aceptan pesos negativos:
+// w'(u,v) = w + h[u] - h[v] >= 0 y d(s,v) = d'(s,v) - h[s] + h[v].
+void dijkstra(const GrafoCSR& g, int s, double* fila, const vector<double>* potencial = nullptr) {
+    typedef pair<double, int> Elemento;
+    priority_queue<Elemento, vector<Elemento>, greater<Elemento>> cola;
+    fill(fila, fila + g.V, INF);
+    fila[s] = 0.0;
+    cola.push({0.0, s});
+    while (!cola.empty()) {
+        Elemento actual = cola.top();
+        cola.pop();
+        int u = actual.second;
+        if (actual.first > fila[u]) continue;
+        for (long long e = g.inicio[u]; e < g.inicio[u + 1]; ++e) {
+            int v = g.destino[e];
+            double w = g.peso[e];
+            if (potencial != nullptr) w += (*potencial)[u] - (*potencial)[v];
+            double nueva = actual.first + w;
+            if (nueva < fila[v]) {
+                fila[v] = nueva;
+                cola.push({nueva, v});
+            }
+        }
+    }
+    if (potencial != nullptr) {
+        for (int v = 0; v < g.V; ++v) {
+            if (fila[v] != INF) fila[v] += (*potencial)[v] - (*potencial)[s];
+        }
+    }
+}
+
+// Potenciales de Johnson por Bellman-Ford desde una fuente virtual.
+// Devuelve false si hay un ciclo negativo.
+bool potencialJohnson(const GrafoCSR& g, vector<double>& h) {
+    h.assign(g.V, 0.0);
+    for (int ronda = 0; ronda <= g.V; ++ronda) {
+        bool cambio = false;
+        for (int u = 0; u < g.V; ++u) {
+            for (long long e = g.inicio[u]; e < g.inicio[u + 1]; ++e) {
+                double nueva = h[u] + g.peso[e];
+                if (nueva < h[g.destino[e]]) {
+                    h[g.destino[e]] = nueva;
+                    cambio = true;
+                }
+            }
+        }
+        if (!cambio) return true;
+    }
+    return false;
+}
+
+// APSP perezoso: cada fila d(s, *) se calcula la primera vez que se pide
+// y se guarda en un caché LRU limitado por memoria. Si dos hilos piden la
+// misma fila, uno la calcula y el otro espera su resultado. Cuando el costo
+// acumulado de los fallos de caché se acerca al de un Floyd-Warshall
+// completo, se lanza la solución completa en segundo plano y, al terminar,
+// todas las consultas se responden desde la matriz.
+#define FACTOR_SOLUCION_COMPLETA 0.25
+
+typedef shared_ptr<const double> FilaDistancias;
+
+struct APSPPerezoso {
+    GrafoCSR grafo;
+    size_t memoriaMax = 0;         // bytes para el caché (y la matriz completa)
+    vector<double> potencial;      // solo si hay pesos negativos
+    bool usaPotencial = false;
+    bool cicloNegativo = false;
+
+    mutex candado;
+    list<int> lru;                 // más reciente al frente
+    unordered_map<int, pair<FilaDistancias, list<int>::iterator>> cache;
+    unordered_map<int, shared_future<FilaDistancias>> enCurso;
+    size_t filasMax = 0;
+    long long aciertos = 0;
+    long long fallos = 0;
+
+    double costeFila = 0;
+    double costeCompleto = 0;
+    bool completaIniciada = false;
+    shared_ptr<vector<double>> completa;
+    thread solucionCompleta;
+};
+
+void iniciarAPSPPerezoso(APSPPerezoso& a, GrafoCSR grafo, size_t memoriaMax) {
+    a.grafo = move(grafo);
+    a.memoriaMax = memoriaMax;
+    int V = a.grafo.V;
+    a.filasMax = max<size_t>(1, memoriaMax / (max(V, 1) * sizeof(double)));
+
+    bool hayNegativos = false;
+    for (double w : a.grafo.peso) hayNegativos = hayNegativos || w < 0;
+    if (hayNegativos) {
+        a.usaPotencial = true;
+        a.cicloNegativo = !potencialJohnson(a.grafo, a.potencial);
+        if (a.cicloNegativo) cerr << "Error: El grafo tiene un ciclo negativo" << endl;
+    }
+
+    double E = a.grafo.destino.size();
+    a.costeFila = (E + V) * log2(V + 2.0);
+    a.costeCompleto = (double)V * V * V / omp_get_max_threads();
+}
+
+// Se llama con el candado tomado. Mientras corre la solución completa, la
+// matriz y el caché conviven: el caché se reduce a lo que deja la matriz
+// dentro de memoriaMax.
+void lanzarSolucionCompleta(APSPPerezoso& a) {
+    a.completaIniciada = true;
+    size_t bytesFila = max(a.grafo.V, 1) * sizeof(double);
+    a.filasMax = (a.memoriaMax - (size_t)a.grafo.V * bytesFila) / bytesFila;
+    while (a.cache.size() > a.filasMax) {
+        a.cache.erase(a.lru.back());
+        a.lru.pop_back();
+    }
+    a.solucionCompleta = thread([&a]() {
+        int V = a.grafo.V;
+        auto matriz = make_shared<vector<double>>((size_t)V * V, INF);
+        for (int u = 0; u < V; ++u) {
+            (*matriz)[(size_t)u * V + u] = 0.0;
+            for (long long e = a.grafo.inicio[u]; e < a.grafo.inicio[u + 1]; ++e) {
+                double& celda = (*matriz)[(size_t)u * V + a.grafo.destino[e]];
+                celda = min(celda, a.grafo.peso[e]);
+            }
+        }
+        floydWarshallOMPOptimized(*matriz, V);
+        lock_guard<mutex> guardia(a.candado);
+        a.completa = matriz;
+        a.cache.clear();
+        a.lru.clear();
+    });
+}
+
+// Devuelve la fila d(s, *) con V valores, o nullptr si hay un ciclo negativo.
+FilaDistancias filaPerezosa(APSPPerezoso& a, int s) {
+    if (a.cicloNegativo) return nullptr;
+    int V = a.grafo.V;
+    promise<FilaDistancias> resultado;
+    {
+        unique_lock<mutex> guardia(a.candado);
+        if (a.completa) {
+            // Alias a la fila dentro de la matriz completa
+            return FilaDistancias(a.completa, a.completa->data() + (size_t)s * V);
+        }
+        auto it = a.cache.find(s);
+        if (it != a.cache.end()) {
+            a.aciertos++;
+            a.lru.splice(a.lru.begin(), a.lru, it->second.second);
+            return it->second.first;
+        }
+        auto pendiente = a.enCurso.find(s);
+        if (pendiente != a.enCurso.end()) {
+            shared_future<FilaDistancias> futuro = pendiente->second;
+            guardia.unlock();
+            return futuro.get();
+        }
+        a.fallos++;
+        a.enCurso[s] = resultado.get_future().share();
+        bool cabeMatriz = (double)V * V * sizeof(double) <= (double)a.memoriaMax;
+        if (!a.completaIniciada && cabeMatriz &&
+            a.fallos * a.costeFila >= FACTOR_SOLUCION_COMPLETA * a.costeCompleto) {
+            lanzarSolucionCompleta(a);
+        }
+    }
+
+    auto fila = shared_ptr<double>(new double[V], default_delete<double[]>());
+    dijkstra(a.grafo, s, fila.get(), a.usaPotencial ? &a.potencial : nullptr);
+
+    {
+        lock_guard<mutex> guardia(a.candado);
+        if (!a.completa) {
+            a.lru.push_front(s);
+            a.cache[s] = {fila, a.lru.begin()};
+            while (a.cache.size() > a.filasMax) {
+                a.cache.erase(a.lru.back());
+                a.lru.pop_back();
+            }
+        }
+        a.enCurso.erase(s);
+    }
+    resultado.set_value(fila);
+    return fila;
+}
+
+double distanciaPerezosa(APSPPerezoso& a, int u, int v) {
+    FilaDistancias fila = filaPerezosa(a, u);
+    return fila ? fila.get()[v] : -INF;
+}
+
+void cerrarAPSPPerezoso(APSPPerezoso& a) {
+    if (a.solucionCompleta.joinable()) a.solucionCompleta.join();
+}
+
+// Oráculo aproximado de distancias con landmarks.
+// Para L vértices de referencia se guardan d(l, v) y d(v, l) en float
+// (2·V·L·4 bytes en lugar de V·V·8) y cada consulta se responde en O(L):
+//   superior: d(u,v) <= d(u,l) + d(l,v)
+//   inferior: d(u,v) >= d(l,v) - d(l,u)  y  d(u,v) >= d(u,l) - d(v,l)
+// Guardar en float redondea cada valor hasta 2^-24 de su magnitud; las
+// consultas operan en double y agregan una holgura de 2^-23·(|x| + |y|)
+// para que las cotas sigan siendo válidas.
+#define HOLGURA_FLOAT (1.0 / (1 << 23))
+struct OraculoLandmarks {
+    int V = 0;
+    int L = 0;
+    vector<int> landmarks;
+    vector<float> desde;  // desde[v * L + l] = d(landmark l, v)
+    vector<float> hacia;  // hacia[v * L + l] = d(v, landmark l)
+    bool pesosNoNegativos = true;
+};
+
+GrafoCSR transponerCSR(const GrafoCSR& g) {
+    vector<int> origenes, destinos;
+    origenes.reserve(g.destino.size());
+    destinos.reserve(g.destino.size());
+    for (int u = 0; u < g.V; ++u) {
+        for (long long e = g.inicio[u]; e < g.inicio[u + 1]; ++e) {
+            origenes.push_back(g.destino[e]);
+            destinos.push_back(u);
+        }
+    }
+    return construirCSR(g.V, origenes, destinos, g.peso);
+}
+
+// Devuelve false si el grafo tiene un ciclo negativo.
+bool construirOraculo(OraculoLandmarks& o, const GrafoCSR& g, int L, unsigned semilla = 1) {
+    int V = g.V;
+    L = min(L, V);
+    o.V = V;
+    o.L = L;
+
+    // Landmarks al azar, sin repetir
+    vector<int> vertices(V);
+    for (int i = 0; i < V; ++i) vertices[i] = i;
+    mt19937_64 gen(semilla);
+    for (int i = 0; i < L; ++i) {
+        uniform_int_distribution<int> dist(i, V - 1);
+        swap(vertices[i], vertices[dist(gen)]);
+    }
+    o.landmarks.assign(vertices.begin(), vertices.begin() + L);
+
+    GrafoCSR transpuesto = transponerCSR(g);
+    vector<double> potencial, potencialTranspuesto;
+    o.pesosNoNegativos = true;
+    for (double w : g.peso) o.pesosNoNegativos = o.pesosNoNegativos && w >= 0;
+    if (!o.pesosNoNegativos) {
+        if (!potencialJohnson(g, potencial)) {
+            cerr << "Error: El grafo tiene un ciclo negativo" << endl;
+            return false;
+        }
+        // En el transpuesto sirve el potencial con signo contrario
+        potencialTranspuesto.resize(V);
+        for (int v = 0; v < V; ++v) potencialTranspuesto[v] = -potencial[v];
+    }
+
+    o.desde.resize((size_t)V * L);
+    o.hacia.resize((size_t)V * L);
+    // 2L búsquedas independientes: L hacia adelante y L en el transpuesto
+    #pragma omp parallel
+    {
+        vector<double> fila(V);
+        #pragma omp for schedule(dynamic)
+        for (int t = 0; t < 2 * L; ++t) {
+            int l = t % L;
+            bool adelante = t < L;
+            if (adelante) {
+                dijkstra(g, o.landmarks[l], fila.data(), o.pesosNoNegativos ? nullptr : &potencial);
+            } else {
+                dijkstra(transpuesto, o.landmarks[l], fila.data(),
+                         o.pesosNoNegativos ? nullptr : &potencialTranspuesto);
+            }
+            vector<float>& destino = adelante ? o.desde : o.hacia;
+            for (int v = 0; v < V; ++v) {
+                destino[(size_t)v * L + l] = (float)fila[v];
+            }
+        }
+    }
+    return true;
+}
+
+inline double cotaSuperior(const OraculoLandmarks& o, int u, int v) {
+    if (u == v) return 0.0;
+    const float* haciaU = &o.hacia[(size_t)u * o.L];
+    const float* desdeV = &o.desde[(size_t)v * o.L];
+    double cota = INF;
+    for (int l = 0; l < o.L; ++l) {
+        double x = haciaU[l], y = desdeV[l];
+        cota = min(cota, x + y + HOLGURA_FLOAT * (fabs(x) + fabs(y)));
+    }
+    return cota;
+}
+
+// x - y redondeado hacia abajo; con un INF no hay holgura que restar
+inline double diferenciaInferior(double x, double y) {
+    if (x == INF || y == INF) return x - y;
+    return x - y - HOLGURA_FLOAT * (fabs(x) + fabs(y));
+}
+
+// INF significa que v no es alcanzable desde u
+inline double cotaInferior(const OraculoLandmarks& o, int u, int v) {
+    if (u == v) return 0.0;
+    const float* desdeU = &o.desde[(size_t)u * o.L];
+    const float* desdeV = &o.desde[(size_t)v * o.L];
+    const float* haciaU = &o.hacia[(size_t)u * o.L];
+    const float* haciaV = &o.hacia[(size_t)v * o.L];
+    double cota = o.pesosNoNegativos ? 0.0 : -INF;
+    for (int l = 0; l < o.L; ++l) {
+        // INF - INF da NaN y la comparación lo descarta
+        double a = diferenciaInferior(desdeV[l], desdeU[l]);
+        double b = diferenciaInferior(haciaU[l], haciaV[l]);
+        if (a > cota) cota = a;
+        if (b > cota) cota = b;
+    }
+    return cota;
+}
+
+// Compara el oráculo contra floydWarshallOMPOptimized en cada archivo y
+// escribe por línea: L, error relativo medio de la cota superior, % de
+// pares exactos, brecha relativa media de la cota inferior, % de pares
+// alcanzables sin cota superior finita y memoria del oráculo / matriz.
+void evaluarOraculo(vector<string> archivos, int L, string salida) {
+    ofstream archivoSalida(salida);
+    for (size_t i = 0; i < archivos.size(); i++) {
+        GrafoCSR g = leerGrafoCSR(archivos[i]);
+        vector<double> exacta = leerGrafoAplanado(archivos[i]);
+        int V = g.V;
+        if (V == 0) continue;
+
+        OraculoLandmarks o;
+        auto inicio = chrono::high_resolution_clock::now();
+        if (!construirOraculo(o, g, L)) continue;
+        auto fin = chrono::high_resolution_clock::now();
+        chrono::duration<double> tiempoOraculo = fin - inicio;
+        floydWarshallOMPOptimized(exacta, V);
+
+        double errorSuperior = 0, brechaInferior = 0;
+        long long pares = 0, exactos = 0, sinCota = 0;
+        #pragma omp parallel for schedule(dynamic, 16) reduction(+:errorSuperior, brechaInferior, pares, exactos, sinCota)
+        for (int u = 0; u < V; ++u) {
+            for (int v = 0; v < V; ++v) {
+                double d = exacta[(size_t)u * V + v];
+                if (u == v || d == INF || d <= 0) continue;
+                double sup = cotaSuperior(o, u, v);
+                double inf = cotaInferior(o, u, v);
+                pares++;
+                if (sup == INF) {
+                    sinCota++;
+                    continue;
+                }
+                errorSuperior += (sup - d) / d;
+                brechaInferior += (d - max(inf, 0.0)) / d;
+                if (sup - d < 1e-3) exactos++;
+            }
+        }
+        double memoria = 2.0 * V * o.L * sizeof(float) / ((double)V * V * sizeof(double));
+        long long conCota = max(pares - sinCota, 1LL);
+        archivoSalida << archivos[i] << " " << o.L << " " << errorSuperior / conCota << " "
+                      << 100.0 * exactos / conCota << " " << brechaInferior / conCota << " "
+                      << 100.0 * sinCota / max(pares, 1LL) << " " << memoria << " "
+                      << tiempoOraculo.count() << endl;
+    }
+    archivoSalida.close();
+}
+
+// Exportación comprimida de la matriz resuelta.
+// La matriz se parte en tiles de TILE_EXPORTACION x TILE_EXPORTACION y cada
+// tile se comprime por separado:
+//  - cuantización a 4 decimales (la precisión de los archivos de entrada)
+//    relativa al mínimo del tile; INF se codifica como 0
+//  - diferencias entre valores consecutivos del tile en orden por filas
+//  - zigzag + varint; un 0 indica una racha de diferencias nulas (p. ej.
+//    bloques de INF) y le sigue su longitud
+// Los hilos comprimen tiles distintos, reservan su lugar en el archivo con
+// un contador atómico y los escriben con pwrite. El índice (desplazamiento
+// y tamaño de cada tile) va después de la cabecera, así que cualquier tile
+// se puede leer sin descomprimir el resto.
+#define TILE_EXPORTACION 256
+#define ESCALA_EXPORTACION 10000.0
+// Límites al leer: V*V tiene que caber en int como en el resto del solver, y
+// un tile ocupa al menos 2 bytes (la base y un token)
+#define MAX_V_EXPORTACION 46340
+#define MIN_BYTES_TILE 2
+
+struct CabeceraExportacion {
+    char magia[4];
+    int32_t V;
+    int32_t tile;
+    int32_t bloques;  // tiles por lado
+};
+
+struct EntradaIndice {
+    uint64_t desplazamiento;
+    uint64_t bytes;
+};
+
+void escribirVarint(vector<uint8_t>& salida, uint64_t x) {
+    while (x >= 0x80) {
+        salida.push_back((uint8_t)(x | 0x80));
+        x >>= 7;
+    }
+    salida.push_back((uint8_t)x);
+}
+
+// Devuelve false si el varint se sale de [p, fin) o no cabe en 64 bits
+bool leerVarint(const uint8_t*& p, const uint8_t* fin, uint64_t& x) {
+    x = 0;
+    for (int corrimiento = 0; corrimiento < 64; corrimiento += 7) {
+        if (p == fin) return false;
+        uint8_t byte = *p++;
+        x |= (uint64_t)(byte & 0x7f) << corrimiento;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int64_t x) { return ((uint64_t)x << 1) ^ (uint64_t)(x >> 63); }
+inline int64_t deshacerZigzag(uint64_t x) { return (int64_t)(x >> 1) ^ -(int64_t)(x & 1); }
+
+void comprimirTile(const vector<double>& dist, int V, int r_i, int r_j, vector<uint8_t>& salida) {
+    int i_end = min(r_i + TILE_EXPORTACION, V);
+    int j_end = min(r_j + TILE_EXPORTACION, V);
+    int64_t base = INT64_MAX;
+    for (int i = r_i; i < i_end; ++i) {
+        for (int j = r_j; j < j_end; ++j) {
+            double d = dist[(size_t)i * V + j];
+            if (d != INF) base = min(base, (int64_t)llround(d * ESCALA_EXPORTACION));
+        }
+    }
+    if (base == INT64_MAX) base = 0;
+
+    salida.clear();
+    escribirVarint(salida, zigzag(base));
+    uint64_t anterior = 0;
+    uint64_t racha = 0;
+    for (int i = r_i; i < i_end; ++i) {
+        for (int j = r_j; j < j_end; ++j) {
+            double d = dist[(size_t)i * V + j];
+            uint64_t codigo = d == INF ? 0 : (uint64_t)(llround(d * ESCALA_EXPORTACION) - base) + 1;
+            int64_t diferencia = (int64_t)(codigo - anterior);
+            anterior = codigo;
+            if (diferencia == 0) {
+                racha++;
+                continue;
+            }
+            if (racha > 0) {
+                escribirVarint(salida, 0);
+                escribirVarint(salida, racha);
+                racha = 0;
+            }
+            escribirVarint(salida, zigzag(diferencia));
+        }
+    }
+    if (racha > 0) {
+        escribirVarint(salida, 0);
+        escribirVarint(salida, racha);
+    }
+}
+
+// Descomprime las celdas del tile en destino, en orden por filas. Devuelve
+// false si los datos se acaban antes de llenar el tile o una racha lo desborda
+bool descomprimirTile(const uint8_t* p, const uint8_t* fin, size_t celdas, double* destino) {
+    uint64_t token;
+    if (!leerVarint(p, fin, token)) return false;
+    int64_t base = deshacerZigzag(token);
+    uint64_t codigo = 0;
+    size_t c = 0;
+    while (c < celdas) {
+        if (!leerVarint(p, fin, token)) return false;
+        uint64_t repeticiones = 1;
+        if (token == 0) {
+            if (!leerVarint(p, fin, repeticiones)) return false;
+            if (repeticiones > (uint64_t)(celdas - c)) return false;
+        } else {
+            codigo += (uint64_t)deshacerZigzag(token);
+        }
+        double valor = codigo == 0 ? INF : (double)((int64_t)(codigo - 1) + base) / ESCALA_EXPORTACION;
+        for (uint64_t r = 0; r < repeticiones; ++r) destino[c++] = valor;
+    }
+    return true;
+}
+
+bool exportarMatriz(const vector<double>& dist, int V, string ruta) {
+    int fd = open(ruta.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "Error: No se pudo crear el archivo " << ruta << endl;
+        return false;
+    }
+    int bloques = (V + TILE_EXPORTACION - 1) / TILE_EXPORTACION;
+    vector<EntradaIndice> indice((size_t)bloques * bloques);
+    uint64_t inicioDatos = sizeof(CabeceraExportacion) + indice.size() * sizeof(EntradaIndice);
+    atomic<uint64_t> siguiente(inicioDatos);
+    bool ok = true;
+
+    #pragma omp parallel
+    {
+        vector<uint8_t> bufer;
+        #pragma omp for schedule(dynamic) reduction(&&:ok)
+        for (int t = 0; t < bloques * bloques; ++t) {
+            comprimirTile(dist, V, (t / bloques) * TILE_EXPORTACION, (t % bloques) * TILE_EXPORTACION, bufer);
+            uint64_t desplazamiento = siguiente.fetch_add(bufer.size());
+            ok = escribirCompleto(fd, bufer.data(), bufer.size(), desplazamiento) && ok;
+            indice[t] = {desplazamiento, bufer.size()};
+        }
+    }
+
+    CabeceraExportacion cabecera = {{'F', 'W', 'E', 'X'}, V, TILE_EXPORTACION, bloques};
+    ok = ok && escribirCompleto(fd, &cabecera, sizeof(cabecera), 0);
+    ok = ok && escribirCompleto(fd, indice.data(), indice.size() * sizeof(EntradaIndice), sizeof(cabecera));
+    close(fd);
+    if (!ok) cerr << "Error: Fallo al escribir " << ruta << endl;
+    return ok;
+}
+
+// Lector por tiles de un archivo exportado
+struct LectorExportado {
+    int fd = -1;
+    int V = 0;
+    int tile = 0;
+    int bloques = 0;
+    vector<EntradaIndice> indice;
+};
+
+// Valida la cabecera (tile fijo, V acotado), que el archivo tenga al menos el
+// tamaño mínimo que implica y que cada entrada del índice apunte dentro del
+// archivo, después de la cabecera y el propio índice
+bool abrirExportado(string ruta, LectorExportado& lector) {
+    lector.fd = open(ruta.c_str(), O_RDONLY);
+    if (lector.fd < 0) {
+        cerr << "Error: No se pudo abrir el archivo " << ruta << endl;
+        return false;
+    }
+    struct stat info;
+    CabeceraExportacion cabecera;
+    bool valido = fstat(lector.fd, &info) == 0 &&
+                  pread(lector.fd, &cabecera, sizeof(cabecera), 0) == sizeof(cabecera) &&
+                  memcmp(cabecera.magia, "FWEX", 4) == 0 &&
+                  cabecera.V > 0 && cabecera.V <= MAX_V_EXPORTACION &&
+                  cabecera.tile == TILE_EXPORTACION &&
+                  cabecera.bloques == (cabecera.V - 1) / cabecera.tile + 1;
+    uint64_t tamano = valido ? (uint64_t)info.st_size : 0;
+    uint64_t inicioDatos = 0;
+    if (valido) {
+        uint64_t tiles = (uint64_t)cabecera.bloques * cabecera.bloques;
+        inicioDatos = sizeof(cabecera) + tiles * sizeof(EntradaIndice);
+        valido = inicioDatos + tiles * MIN_BYTES_TILE <= tamano;
+    }
+    if (valido) {
+        lector.V = cabecera.V;
+        lector.tile = cabecera.tile;
+        lector.bloques = cabecera.bloques;
+        lector.indice.resize((size_t)lector.bloques * lector.bloques);
+        size_t bytes = lector.indice.size() * sizeof(EntradaIndice);
+        valido = pread(lector.fd, lector.indice.data(), bytes, sizeof(cabecera)) == (ssize_t)bytes;
+    }
+    for (size_t t = 0; valido && t < lector.indice.size(); ++t) {
+        const EntradaIndice& entrada = lector.indice[t];
+        valido = entrada.desplazamiento >= inicioDatos && entrada.desplazamiento <= tamano &&
+                 entrada.bytes >= MIN_BYTES_TILE && entrada.bytes <= tamano - entrada.desplazamiento;
+    }
+    if (!valido) {
+        cerr << "Error: Archivo exportado no valido " << ruta << endl;
+        close(lector.fd);
+        lector.fd = -1;
+        lector.indice.clear();
+        return false;
+    }
+    return true;
+}
+
+// Lee el tile (ib, jb); queda por filas con min(tile, V - jb*tile) columnas
+bool leerTileExportado(const LectorExportado& lector, int ib, int jb, vector<double>& tile) {
+    if (ib < 0 || ib >= lector.bloques || jb < 0 || jb >= lector.bloques) return false;
+    const EntradaIndice& entrada = lector.indice[(size_t)ib * lector.bloques + jb];
+    vector<uint8_t> comprimido(entrada.bytes);
+    if (pread(lector.fd, comprimido.data(), entrada.bytes, entrada.desplazamiento) != (ssize_t)entrada.bytes) {
+        return false;
+    }
+    int filas = min(lector.tile, lector.V - ib * lector.tile);
+    int columnas = min(lector.tile, lector.V - jb * lector.tile);
+    size_t celdas = (size_t)filas * columnas;
+    tile.resize(celdas);
+    return descomprimirTile(comprimido.data(), comprimido.data() + comprimido.size(), celdas, tile.data());
+}
+
+void cerrarExportado(LectorExportado& lector) {
+    if (lector.fd >= 0) close(lector.fd);
+    lector.fd = -1;
+}
+
+// Reconstruye la matriz completa leyendo los tiles en paralelo
+vector<double> importarMatriz(string ruta, int& V) {
+    LectorExportado lector;
+    if (!abrirExportado(ruta, lector)) return {};
+    // La matriz completa tiene que caber en la memoria física
+    double bytesMatriz = (double)lector.V * lector.V * sizeof(double);
+    if (bytesMatriz > (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE)) {
+        cerr << "Error: La matriz de " << ruta << " no cabe en memoria" << endl;
+        cerrarExportado(lector);
+        return {};
+    }
+    V = lector.V;
+    vector<double> dist((size_t)V * V);
+    bool ok = true;
+    #pragma omp parallel
+    {
+        vector<double> tile;
+        #pragma omp for schedule(dynamic) reduction(&&:ok)
+        for (int t = 0; t < lector.bloques * lector.bloques; ++t) {
+            int ib = t / lector.bloques, jb = t % lector.bloques;
+            if (!leerTileExportado(lector, ib, jb, tile)) {
+                ok = false;
+                continue;
+            }
+            int columnas = min(lector.tile, V - jb * lector.tile);
+            for (size_t c = 0; c < tile.size(); ++c) {
+                int i = ib * lector.tile + c / columnas;
+                int j = jb * lector.tile + c % columnas;
+                dist[(size_t)i * V + j] = tile[c];
+            }
+        }
+    }
+    cerrarExportado(lector);
+    if (!ok) {
+        cerr << "Error: Fallo al leer " << ruta << endl;
+        return {};
+    }
+    return dist;
 }
 
 void ejecutar(vector<string> archivos,string salida){
@@ -300,17 +1829,284 @@ void ejecutar2(vector<string> archivos,string salida,int tam){
         ifstream entrada(archivos[i]);
         vector<double>grafo = leerGrafoAplanado(archivos[i]);
         auto inicio=chrono::high_resolution_clock::now();
-        //floydWarshallSecuencialOptimizado(grafo,tam);
-        //blocked_floyd_warshall(grafo,tam);
-        floydWarshallOMPOptimized(grafo,tam);
+        vector<int> ciclo;
+        bool negativo;
+        //negativo = floydWarshallSecuencialOptimizado(grafo,tam,&ciclo);
+        //negativo = blocked_floyd_warshall(grafo,tam,&ciclo);
+        //negativo = floydWarshallReordenado(grafo,tam,ORDEN_COMPONENTES,floydWarshallOMPOptimized,&ciclo);
+        //negativo = floydWarshallParticionado(grafo,tam,&ciclo);
+        negativo = floydWarshallOMPOptimized(grafo,tam,&ciclo);
         auto fin=chrono::high_resolution_clock::now();
         chrono::duration<double> duracion = fin-inicio;
+        if (negativo) {
+            cerr << "Ciclo negativo en " << archivos[i] << ", vertices:";
+            for (int v : ciclo) cerr << " " << v;
+            cerr << endl;
+        }
         archivoSalida<<duracion.count() <<endl;
+        //exportarMatriz(grafo,tam,archivos[i]+".fwex");
         entrada.close();
     }
     archivoSalida.close();
 }
 
+// Barrido de escalabilidad sin archivos: cada grafo se genera en memoria
+// con la semilla dada y se resuelve. Escribe por línea: N, densidad,
+// repetición, segundos de generación y segundos de solución.
+void ejecutarEnMemoria(vector<int> tamanos, vector<int> densidades, int repeticiones,
+                       string salida, unsigned long long semilla){
+    ofstream archivoSalida(salida);
+    for (int tam : tamanos) {
+        for (int densidad : densidades) {
+            for (int r = 0; r < repeticiones; r++) {
+                vector<double> grafo;
+                auto inicio=chrono::high_resolution_clock::now();
+                generarGrafoDirigidoAplanado(tam, densidad, 1, 1000, semilla + r, grafo);
+                auto medio=chrono::high_resolution_clock::now();
+                floydWarshallOMPOptimized(grafo,tam);
+                auto fin=chrono::high_resolution_clock::now();
+                chrono::duration<double> generacion = medio-inicio;
+                chrono::duration<double> solucion = fin-medio;
+                archivoSalida<<tam<<" "<<densidad<<" "<<r<<" "<<generacion.count()<<" "<<solucion.count()<<endl;
+            }
+        }
+    }
+    archivoSalida.close();
+}
+
+// Igual que ejecutar2 para un solo archivo, pero con checkpoints.
+// Si rutaCheckpoint ya tiene un checkpoint válido se continúa desde ahí.
+void ejecutarConCheckpoint(string archivo, string rutaCheckpoint, string salida){
+    ofstream archivoSalida(salida, ios::app);
+    vector<double> grafo;
+    int tam, k;
+    Checkpoint ckpt;
+    ckpt.ruta = rutaCheckpoint;
+    ckpt.identidad = identidadArchivo(archivo);
+    if (reanudarCheckpoint(rutaCheckpoint, ckpt.identidad, grafo, tam, k)) {
+        cout << "Reanudando " << archivo << " desde k = " << k << endl;
+        ckpt.kInicio = k;
+    } else {
+        grafo = leerGrafoAplanado(archivo);
+        tam = (int)sqrt((double)grafo.size());
+    }
+    vector<int> ciclo;
+    auto inicio=chrono::high_resolution_clock::now();
+    bool negativo = floydWarshallOMPOptimized(grafo,tam,&ciclo,&ckpt);
+    auto fin=chrono::high_resolution_clock::now();
+    chrono::duration<double> duracion = fin-inicio;
+    if (negativo) {
+        cerr << "Ciclo negativo en " << archivo << ", vertices:";
+        for (int v : ciclo) cerr << " " << v;
+        cerr << endl;
+    }
+    archivoSalida<<duracion.count() <<endl;
+    archivoSalida.close();
+}
+
+// Microbenchmarks de los kernels con línea base por máquina.
+// Compilar con -DMICROBENCH para que main corra la suite.
+// Cada kernel se mide con matrices que caben en L2, en L3 y que solo caben
+// en DRAM, a varias densidades y números de hilos. El rendimiento
+// (relajaciones/s o aristas/s, el mejor de REPETICIONES_BENCH) se compara
+// con microbench_<host>.txt; si baja más que el umbral de ruido se reporta
+// como regresión y la suite termina con código 1.
+#define REPETICIONES_BENCH 3
+
+struct ResultadoBench {
+    string kernel;
+    int N;
+    int densidad;
+    int hilos;
+    double rendimiento;
+};
+
+void escribirListaAristas(const vector<double>& dist, int N, string nombreArchivo) {
+    ofstream archivo(nombreArchivo);
+    long long aristas = 0;
+    for (size_t i = 0; i < dist.size(); ++i) {
+        if (dist[i] != INF && i % (N + 1) != 0) aristas++;
+    }
+    archivo << N << " " << aristas << "\n";
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            double w = dist[(size_t)i * N + j];
+            if (i != j && w != INF) archivo << i << " " << j << " " << fixed << setprecision(4) << w << "\n";
+        }
+    }
+}
+
+// Mejor tiempo de REPETICIONES_BENCH corridas; preparar() no se mide
+template <typename Preparar, typename Medir>
+double mejorTiempo(Preparar preparar, Medir medir) {
+    double mejor = INF;
+    for (int r = 0; r < REPETICIONES_BENCH; ++r) {
+        preparar();
+        auto inicio = chrono::high_resolution_clock::now();
+        medir();
+        auto fin = chrono::high_resolution_clock::now();
+        chrono::duration<double> duracion = fin - inicio;
+        mejor = min(mejor, duracion.count());
+    }
+    return mejor;
+}
+
+// Tamaños de matriz: mitad de L2, mitad de L3 (sin pasar de 16 veces L2)
+// y el doble de L3 (sin pasar de 8192 vértices, 512 MB) para que la suite
+// termine en minutos aun con L3 grandes.
+vector<int> tamanosBench() {
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l2 <= 0) l2 = 1 << 20;
+    if (l3 <= 0) l3 = 32 << 20;
+    auto lado = [](double bytes) {
+        int n = (int)sqrt(bytes / sizeof(double));
+        return min(8192, max(B, n / B * B));
+    };
+    return {lado(l2 / 2.0), lado(min(l3 / 2.0, 16.0 * l2)), lado(l3 * 2.0)};
+}
+
+vector<ResultadoBench> correrMicrobenchmarks() {
+    vector<ResultadoBench> resultados;
+    vector<int> tamanos = tamanosBench();
+    vector<int> densidades = {25, 50, 100};
+    int maxHilos = omp_get_max_threads();
+    vector<int> hilos = {1};
+    if (maxHilos / 2 > 1) hilos.push_back(maxHilos / 2);
+    if (maxHilos > 1) hilos.push_back(maxHilos);
+
+    for (size_t t = 0; t < tamanos.size(); ++t) {
+        int N = tamanos[t];
+        bool cabeEnCache = t == 0;
+        bool dram = t == tamanos.size() - 1;
+        for (int densidad : densidades) {
+            vector<double> original;
+            generarGrafoDirigidoAplanado(N, densidad, 1, 1000, N * 100 + densidad, original);
+            vector<double> dist;
+            auto copiar = [&]() { dist = original; };
+
+            // Lectores: no dependen de los hilos. En DRAM el archivo de
+            // texto pasaría de gigabytes, así que solo se miden en caché y L3.
+            if (!dram) {
+                string archivo = "microbench_" + to_string(N) + "_" + to_string(densidad) + ".txt";
+                escribirListaAristas(original, N, archivo);
+                double aristas = 0;
+                for (size_t i = 0; i < original.size(); ++i) aristas += original[i] != INF;
+                aristas -= N;
+                double tLector = mejorTiempo([]() {}, [&]() { leerGrafoAplanado(archivo); });
+                resultados.push_back({"leerGrafoAplanado", N, densidad, 1, aristas / tLector});
+                tLector = mejorTiempo([]() {}, [&]() { leerGrafoCSR(archivo); });
+                resultados.push_back({"leerGrafoCSR", N, densidad, 1, aristas / tLector});
+                remove(archivo.c_str());
+            }
+
+            for (int h : hilos) {
+                omp_set_num_threads(h);
+
+                // update_block: un barrido tipo fase 3 de un bloque k
+                int bloques = N / B;
+                int kb = bloques / 2;
+                vector<ResumenBloque> resumen(bloques * bloques);
+                double tBloque = mejorTiempo(copiar, [&]() {
+                    #pragma omp parallel for schedule(dynamic)
+                    for (int ib = 0; ib < bloques; ++ib) {
+                        for (int jb = 0; jb < bloques; ++jb) {
+                            if (ib == kb || jb == kb) continue;
+                            ResumenBloque& r = resumen[ib * bloques + jb];
+                            r = {0, B * B, INF, -INF, false};
+                            update_block(dist, N, ib * B, jb * B, kb * B, kb * B, r);
+                        }
+                    }
+                });
+                double relajaciones = (double)(bloques - 1) * (bloques - 1) * B * B * B;
+                resultados.push_back({"update_block", N, densidad, h, relajaciones / tBloque});
+
+                // Bucle interno del kernel OMP sobre ~2e8 relajaciones
+                int pasos = max(1, min(N, (int)(2e8 / ((double)N * N))));
+                double tFila = mejorTiempo(copiar, [&]() {
+                    #pragma omp parallel
+                    for (int p = 0; p < pasos; ++p) {
+                        int k = (int)((long long)p * N / pasos);
+                        #pragma omp for schedule(static)
+                        for (int i = 0; i < N; ++i) {
+                            double dist_ik = dist[(size_t)i * N + k];
+                            if (dist_ik == INF) continue;
+                            relajarFila(&dist[(size_t)i * N], &dist[(size_t)k * N], dist_ik, N);
+                        }
+                    }
+                });
+                resultados.push_back({"relajarFila", N, densidad, h, (double)pasos * N * N / tFila});
+
+                // Kernel completo (O(N^3)): solo en el tamaño de caché
+                if (cabeEnCache) {
+                    double tCompleto = mejorTiempo(copiar, [&]() { floydWarshallOMPOptimized(dist, N); });
+                    resultados.push_back({"floydWarshallOMPOptimized", N, densidad, h,
+                                          (double)N * N * N / tCompleto});
+                }
+            }
+            omp_set_num_threads(maxHilos);
+        }
+    }
+    return resultados;
+}
+
+string archivoLineaBase() {
+    char host[256] = "desconocido";
+    gethostname(host, sizeof(host) - 1);
+    return string("microbench_") + host + ".txt";
+}
+
+// Devuelve el número de regresiones. Sin línea base (o con actualizar)
+// se guarda la corrida actual como nueva línea base.
+int microbenchmarks(double umbralRuido, bool actualizar) {
+    string ruta = archivoLineaBase();
+    map<string, double> base;
+    ifstream entrada(ruta);
+    ResultadoBench r;
+    while (entrada >> r.kernel >> r.N >> r.densidad >> r.hilos >> r.rendimiento) {
+        base[r.kernel + " " + to_string(r.N) + " " + to_string(r.densidad) + " " + to_string(r.hilos)] = r.rendimiento;
+    }
+    entrada.close();
+
+    vector<ResultadoBench> resultados = correrMicrobenchmarks();
+    int regresiones = 0;
+    for (auto& res : resultados) {
+        string clave = res.kernel + " " + to_string(res.N) + " " + to_string(res.densidad) + " " + to_string(res.hilos);
+        cout << clave << " " << res.rendimiento;
+        auto it = base.find(clave);
+        if (it != base.end()) {
+            double relativo = res.rendimiento / it->second;
+            cout << " (" << (int)round(relativo * 100) << "% de la linea base)";
+            if (relativo < 1.0 - umbralRuido) {
+                regresiones++;
+                cerr << "REGRESION: " << clave << " bajo a " << res.rendimiento
+                     << " (linea base " << it->second << ")" << endl;
+            }
+        }
+        cout << endl;
+    }
+
+    if (base.empty() || actualizar) {
+        ofstream salida(ruta);
+        salida << setprecision(10);
+        for (auto& res : resultados) {
+            salida << res.kernel << " " << res.N << " " << res.densidad << " " << res.hilos << " "
+                   << res.rendimiento << "\n";
+        }
+        cout << "Linea base guardada en " << ruta << endl;
+    }
+    if (regresiones > 0) {
+        cerr << regresiones << " regresiones por encima del " << umbralRuido * 100 << "% de ruido" << endl;
+    }
+    return regresiones;
+}
+
+#ifdef MICROBENCH
+int main() {
+    // Umbral de ruido del 10%; true para regenerar la línea base
+    return microbenchmarks(0.10, false) > 0 ? 1 : 0;
+}
+#else
 int main() {
     
     
@@ -345,6 +2141,8 @@ int main() {
     //ejecutar2(a,"tiempos_512_serial_opt.txt",512);
     //ejecutar2(c,"tiempos_2048_serial_opt.txt",2048);
     //ejecutar2(e,"tiempos_8192_serial_opt.txt",8192);
+    //evaluarOraculo(e,64,"oraculo_8192_64.txt");
+    //ejecutarEnMemoria({512,1024,2048,4096},{25,50,100},3,"tiempos_memoria_OMP.txt",1);
     
     /*
     ofstream salida("tiempoSerialOpt_1024.txt");
@@ -358,4 +2156,5 @@ int main() {
     salida.close();
     */
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -9,8 +9,14 @@
 #include <algorithm>
 #include <sstream>
 #include <unordered_set>
+#include <limits>
+#include <cmath>
 using namespace std;
+// Con GENERADOR_COMO_BIBLIOTECA definido, este archivo se puede incluir
+// desde el solver: no define main ni INF.
+#ifndef GENERADOR_COMO_BIBLIOTECA
 const double INF = numeric_limits<double>::infinity();
+#endif
 void generarGrafoDirigidoDenso(int numVertices, unsigned long long numAristas,
                                double pesoMin, double pesoMax, string nombreArchivo,
                                mt19937_64& gen) {
@@ -156,8 +162,112 @@ void generarGrafoDirigido(int numVertices, int densidad, double pesoMin, double
 }
 
 
+// Generación en memoria, sin pasar por el archivo de texto.
+// Llena directamente la matriz aplanada o el CSR que usa el solver.
+// Cada fila tiene su propio generador, sembrado con (semilla, fila), así que
+// el resultado es el mismo para una semilla sin importar cuántos hilos se
+// usen. Cada par (i, j) con i != j es arista con probabilidad densidad/100,
+// independiente de los demás: el grado de salida de cada fila es
+// Binomial(n-1, densidad/100) y los destinos son uniformes, como en el
+// conjunto de aristas al azar que escribe generarGrafoDirigido (allí el total
+// es exacto; aquí varía alrededor de n(n-1)*densidad/100). Los pesos se
+// redondean a 4 decimales como en los archivos.
+unsigned long long mezclarSemilla(unsigned long long semilla, unsigned long long fila) {
+    // splitmix64
+    unsigned long long z = semilla + 0x9E3779B97F4A7C15ULL * (fila + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Grado de salida de la fila; es lo primero que se saca del generador de la fila
+unsigned long long aristasDeFila(int numVertices, int densidad, mt19937_64& gen) {
+    binomial_distribution<unsigned long long> distGrado(numVertices - 1, min(1.0, densidad / 100.0));
+    return distGrado(gen);
+}
+
+// Destinos distintos de la fila (sin el bucle fila->fila), ordenados.
+// candidatos es espacio de trabajo del hilo.
+void destinosDeFila(int numVertices, int fila, unsigned long long m, mt19937_64& gen,
+                    vector<int>& candidatos, vector<int>& destinos) {
+    destinos.clear();
+    if (m * 8 < (unsigned long long)numVertices) {
+        // Disperso: muestreo por rechazo
+        unordered_set<int> elegidos;
+        uniform_int_distribution<int> distVertices(0, numVertices - 1);
+        while (elegidos.size() < m) {
+            int destino = distVertices(gen);
+            if (destino != fila && elegidos.insert(destino).second) destinos.push_back(destino);
+        }
+    } else {
+        // Denso: Fisher-Yates parcial sobre los candidatos
+        candidatos.clear();
+        for (int j = 0; j < numVertices; ++j) {
+            if (j != fila) candidatos.push_back(j);
+        }
+        for (unsigned long long k = 0; k < m; ++k) {
+            uniform_int_distribution<unsigned long long> dist(k, candidatos.size() - 1);
+            swap(candidatos[k], candidatos[dist(gen)]);
+        }
+        destinos.assign(candidatos.begin(), candidatos.begin() + m);
+    }
+    sort(destinos.begin(), destinos.end());
+}
+
+void generarGrafoDirigidoAplanado(int numVertices, int densidad, double pesoMin, double pesoMax,
+                                  unsigned long long semilla, vector<double>& dist) {
+    dist.assign((size_t)numVertices * numVertices, numeric_limits<double>::infinity());
+    #pragma omp parallel
+    {
+        vector<int> candidatos, destinos;
+        #pragma omp for schedule(dynamic, 16)
+        for (int i = 0; i < numVertices; ++i) {
+            mt19937_64 gen(mezclarSemilla(semilla, i));
+            uniform_real_distribution<double> distPesos(pesoMin, pesoMax);
+            unsigned long long m = aristasDeFila(numVertices, densidad, gen);
+            destinosDeFila(numVertices, i, m, gen, candidatos, destinos);
+            double* fila = &dist[(size_t)i * numVertices];
+            fila[i] = 0.0;
+            for (int j : destinos) {
+                fila[j] = round(distPesos(gen) * 10000) / 10000;
+            }
+        }
+    }
+}
+
+// Mismo grafo que generarGrafoDirigidoAplanado con la misma semilla, en CSR
+void generarGrafoDirigidoCSR(int numVertices, int densidad, double pesoMin, double pesoMax,
+                             unsigned long long semilla, vector<long long>& inicio,
+                             vector<int>& destino, vector<double>& peso) {
+    // Primera pasada: grados, para conocer el inicio de cada fila
+    inicio.assign(numVertices + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < numVertices; ++i) {
+        mt19937_64 gen(mezclarSemilla(semilla, i));
+        inicio[i + 1] = aristasDeFila(numVertices, densidad, gen);
+    }
+    for (int i = 0; i < numVertices; ++i) inicio[i + 1] += inicio[i];
+    destino.resize(inicio[numVertices]);
+    peso.resize(inicio[numVertices]);
+    #pragma omp parallel
+    {
+        vector<int> candidatos, destinos;
+        #pragma omp for schedule(dynamic, 16)
+        for (int i = 0; i < numVertices; ++i) {
+            mt19937_64 gen(mezclarSemilla(semilla, i));
+            uniform_real_distribution<double> distPesos(pesoMin, pesoMax);
+            aristasDeFila(numVertices, densidad, gen);  // mismo estado que en la primera pasada
+            destinosDeFila(numVertices, i, inicio[i + 1] - inicio[i], gen, candidatos, destinos);
+            for (size_t e = 0; e < destinos.size(); ++e) {
+                destino[inicio[i] + e] = destinos[e];
+                peso[inicio[i] + e] = round(distPesos(gen) * 10000) / 10000;
+            }
+        }
+    }
+}
 
 
+#ifndef GENERADOR_COMO_BIBLIOTECA
 int main(void){
     /*
     generarGrafoDirigido(2048,100,1,1000,"2048_100_1.txt");
@@ -170,4 +280,5 @@ int main(void){
     generarGrafoDirigido(2048,25,1,1000,"2048_25_3.txt");
     */
    generarGrafoDirigido(512,50,1,1000,"512_50_1.txt");
-}
\ No newline at end of file
+}
+#endif